@@ -0,0 +1,23 @@
+// Global operator new and delete that count every allocation, for the
+// memory benchmark's allocations per insert. Only the benchmark program
+// links this file. It is a separate translation unit so that no free()
+// is ever inlined next to the operator new its block came from, which GCC
+// would report as a mismatch.
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+atomic<size_t> allocationCount(0);
+atomic<size_t> allocatedBytes(0);
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    allocatedBytes.fetch_add(size, memory_order_relaxed);
+    if (void* block = malloc(size ? size : 1)) return block;
+    throw bad_alloc();
+}
+
+void operator delete(void* block) noexcept { free(block); }
+void operator delete(void* block, size_t) noexcept { free(block); }
\ No newline at end of file
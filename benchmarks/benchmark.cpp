@@ -0,0 +1,331 @@
+// ==================== Benchmarks ====================
+// Times the main paths of the tracker on generated expenses and prints one
+// line per row count. Built as its own program, so the tracker carries none
+// of this:
+//
+//   g++ -std=c++17 -O2 -pthread -o benchmark benchmarks/benchmark.cpp benchmarks/allocation_count.cpp
+//   ./benchmark load|kernels|memory [ROWS...]
+//
+//   load [ROWS...]     first start on a legacy text file of ROWS expenses,
+//                      which reads it and converts it to month partitions
+//   kernels [ROWS...]  a month's total and a year's per-category totals:
+//                      the linked-list loops the store replaced, the scalar
+//                      kernels and the kernels picked for this CPU
+//   memory [ROWS...]   heap bytes and allocations per expense, and the time
+//                      to drop a month and to clear everything, for the
+//                      linked list, the unordered_multimap description
+//                      index it had and the store with its pooled indexes
+//
+// load writes its files to the working directory under the user name
+// "benchmark" and deletes them afterwards.
+#define EXPENSE_TRACKER_NO_MAIN
+#include "../Expense Tracker.cpp"
+
+const char* const BENCHMARK_USAGE = "Usage: benchmark load|kernels|memory [ROWS...]\n";
+
+const char* const BENCHMARK_USER = "benchmark";
+const char* const BENCHMARK_WORDS[8] = {
+    "Coffee", "Lunch", "Groceries", "Bus fare", "Cinema", "Rent", "Power bill", "Pharmacy"
+};
+
+// Draws expenses from a fixed seed, so every run sees the same data. Dates
+// fall in the 24 months up to the current one.
+class BenchmarkData {
+private:
+    mt19937_64 random{2026};
+    int lastMonth = currentMonthKey();
+
+public:
+    int64_t amount = 0;         // cents
+    int dateKey = 0;
+    int category = 0;           // built-in category id
+    string description;
+
+    void next() {
+        amount = (int64_t)(random() % 50000) + 1;
+        int months = lastMonth / 100 * 12 + lastMonth % 100 - 1 - (int)(random() % 24);
+        dateKey = (months / 12 * 100 + months % 12 + 1) * 100 + (int)(random() % 28) + 1;
+        category = (int)(random() % NUM_BUILTIN_CATEGORIES);
+        description = BENCHMARK_WORDS[random() % 8];
+        description += ' ';
+        description += to_string(random() % 1000);
+    }
+};
+
+// Counted by the operator new of allocation_count.cpp
+extern atomic<size_t> allocationCount;
+extern atomic<size_t> allocatedBytes;
+
+double secondsSince(chrono::steady_clock::time_point started) {
+    return chrono::duration<double>(chrono::steady_clock::now() - started).count();
+}
+
+// Deletes the benchmark user's files. Clearing its expenses removes the
+// month files and leaves the manifest, journal and text file.
+void removeBenchmarkFiles() {
+    string base = string(BENCHMARK_USER) + "_expenses";
+    if (ifstream(base + "/manifest")) {
+        ExpenseEngine engine(BENCHMARK_USER);
+        engine.removeAll();
+    }
+    std::remove((base + "/manifest").c_str());
+    std::remove((base + ".journal").c_str());
+    std::remove((base + ".txt").c_str());
+#ifdef _WIN32
+    RemoveDirectoryA(base.c_str());
+#else
+    rmdir(base.c_str());
+#endif
+}
+
+void writeBenchmarkText(const string& path, size_t rows) {
+    ofstream out(path);
+    BenchmarkData data;
+    out << "Budget Month: " << monthKeyToString(currentMonthKey()) << "\nBudget: 0.00\n";
+    for (size_t i = 0; i < rows; i++) {
+        data.next();
+        out << "Description: " << data.description << "\nAmount: " << formatCents(data.amount)
+            << "\nCategory: " << BUILTIN_CATEGORIES[data.category] << "\nDate: " << dateKeyToString(data.dateKey)
+            << "\n-----\n";
+    }
+}
+
+// Startup time should grow in step with the file: the same time per row
+// at every size
+void benchmarkLoad(const vector<size_t>& sizes) {
+    cout << "Load of a legacy text file\n";
+    cout << setw(12) << "rows" << setw(12) << "seconds" << setw(14) << "us per row" << '\n';
+    for (size_t rows : sizes) {
+        removeBenchmarkFiles();
+        writeBenchmarkText(string(BENCHMARK_USER) + "_expenses.txt", rows);
+        chrono::steady_clock::time_point started = chrono::steady_clock::now();
+        { ExpenseEngine engine(BENCHMARK_USER); }
+        double seconds = secondsSince(started);
+        cout << setw(12) << rows << setw(12) << fixed << setprecision(3) << seconds
+             << setw(14) << setprecision(2) << seconds * 1e6 / rows << endl;
+    }
+    removeBenchmarkFiles();
+}
+
+// A node of the linked list the expenses were kept in before the column
+// store, with the amount as a double and the date as text
+struct BenchmarkNode {
+    double amount;
+    string description;
+    string category;
+    string date;
+    BenchmarkNode* next;
+};
+
+// Best of three runs, in milliseconds
+double bestMilliseconds(const function<void()>& run) {
+    double best = 0;
+    for (int i = 0; i < 3; i++) {
+        chrono::steady_clock::time_point started = chrono::steady_clock::now();
+        run();
+        double milliseconds = secondsSince(started) * 1000;
+        if (i == 0 || milliseconds < best) best = milliseconds;
+    }
+    return best;
+}
+
+void printKernelTimes(size_t rows, const char* query, double list, double scalar, double kernel) {
+    cout << setw(10) << rows << "  " << left << setw(16) << query << right << fixed << setprecision(2)
+         << setw(10) << list << setw(11) << scalar << setw(11) << kernel
+         << setw(10) << setprecision(1) << list / kernel << "x" << setw(10) << scalar / kernel << "x" << endl;
+}
+
+void benchmarkKernels(const vector<size_t>& sizes) {
+    const AggregateKernels& kernels = aggregateKernels();
+    int month = currentMonthKey(), year = month / 100;
+    string monthText = monthKeyToString(month), yearText = to_string(year);
+    cout << "Filtered sums, kernels: " << kernels.name << '\n';
+    cout << setw(10) << "rows" << "  " << left << setw(16) << "query" << right << setw(10) << "list ms"
+         << setw(11) << "scalar ms" << setw(11) << "kernel ms" << setw(11) << "vs list" << setw(11) << "vs scalar" << '\n';
+    for (size_t rows : sizes) {
+        vector<uint64_t> ids(rows);
+        vector<int32_t> dates(rows), categories(rows);
+        vector<int64_t> amounts(rows);
+        BenchmarkNode* head = nullptr;
+        BenchmarkNode** tail = &head;
+        BenchmarkData data;
+        for (size_t i = 0; i < rows; i++) {
+            data.next();
+            ids[i] = i + 1;
+            dates[i] = data.dateKey;
+            categories[i] = data.category;
+            amounts[i] = data.amount;
+            *tail = new BenchmarkNode{data.amount / 100.0, data.description, BUILTIN_CATEGORIES[data.category],
+                                      dateKeyToString(data.dateKey), nullptr};
+            tail = &(*tail)->next;
+        }
+
+        double listTotal = 0;
+        int64_t scalarTotal = 0, kernelTotal = 0;
+        double list = bestMilliseconds([&]() {
+            listTotal = 0;
+            for (BenchmarkNode* node = head; node; node = node->next) {
+                if (node->date.substr(0, 7) == monthText) listTotal += node->amount;
+            }
+        });
+        double scalar = bestMilliseconds([&]() {
+            scalarTotal = sumScalar(ids.data(), dates.data(), amounts.data(), rows, month * 100, month * 100 + 99);
+        });
+        double kernel = bestMilliseconds([&]() {
+            kernelTotal = kernels.sum(ids.data(), dates.data(), amounts.data(), rows, month * 100, month * 100 + 99);
+        });
+        printKernelTimes(rows, "month total", list, scalar, kernel);
+        if (scalarTotal != kernelTotal || llround(listTotal * 100) != kernelTotal) cout << "  totals differ!\n";
+
+        map<string, double> listTotals;
+        vector<int64_t> scalarTotals, kernelTotals;
+        list = bestMilliseconds([&]() {
+            listTotals.clear();
+            for (BenchmarkNode* node = head; node; node = node->next) {
+                if (node->date.compare(0, 4, yearText) == 0) listTotals[node->category] += node->amount;
+            }
+        });
+        scalar = bestMilliseconds([&]() {
+            scalarTotals.assign(NUM_BUILTIN_CATEGORIES, 0);
+            groupScalar(ids.data(), dates.data(), categories.data(), amounts.data(), rows,
+                        year * 10000, year * 10000 + 9999, scalarTotals.data());
+        });
+        kernel = bestMilliseconds([&]() {
+            kernelTotals.assign(NUM_BUILTIN_CATEGORIES, 0);
+            kernels.group(ids.data(), dates.data(), categories.data(), amounts.data(), rows,
+                          year * 10000, year * 10000 + 9999, kernelTotals.data());
+        });
+        printKernelTimes(rows, "category totals", list, scalar, kernel);
+        if (scalarTotals != kernelTotals) cout << "  totals differ!\n";
+
+        while (head) {
+            BenchmarkNode* next = head->next;
+            delete head;
+            head = next;
+        }
+    }
+}
+
+void printMemoryUse(size_t rows, const char* layout, size_t allocations, double bytes, double drop, double clear) {
+    cout << setw(10) << rows << "  " << left << setw(22) << layout << right << fixed << setprecision(2)
+         << setw(11) << (double)allocations / rows << setw(11) << setprecision(1) << bytes / rows;
+    if (drop >= 0) {
+        cout << setw(10) << setprecision(2) << drop;
+    } else {
+        cout << setw(10) << "-";
+    }
+    cout << setw(10) << setprecision(2) << clear << endl;
+}
+
+void benchmarkMemory(const vector<size_t>& sizes) {
+    int month = currentMonthKey();
+    string monthText = monthKeyToString(month);
+    cout << "Memory per expense\n";
+    cout << setw(10) << "rows" << "  " << left << setw(22) << "layout" << right << setw(11) << "allocs/row"
+         << setw(11) << "bytes/row" << setw(10) << "drop ms" << setw(10) << "clear ms" << '\n';
+    for (size_t rows : sizes) {
+        // One node and its strings per expense, freed one at a time
+        BenchmarkData data;
+        BenchmarkNode* head = nullptr;
+        BenchmarkNode** tail = &head;
+        size_t allocations = allocationCount, bytes = allocatedBytes;
+        for (size_t i = 0; i < rows; i++) {
+            data.next();
+            *tail = new BenchmarkNode{data.amount / 100.0, move(data.description), BUILTIN_CATEGORIES[data.category],
+                                      dateKeyToString(data.dateKey), nullptr};
+            tail = &(*tail)->next;
+        }
+        allocations = allocationCount - allocations;
+        bytes = allocatedBytes - bytes;
+        chrono::steady_clock::time_point started = chrono::steady_clock::now();
+        for (BenchmarkNode** link = &head; *link;) {
+            BenchmarkNode* node = *link;
+            if (node->date.compare(0, 7, monthText) == 0) {
+                *link = node->next;
+                delete node;
+            } else {
+                link = &node->next;
+            }
+        }
+        double drop = secondsSince(started) * 1000;
+        started = chrono::steady_clock::now();
+        while (head) {
+            BenchmarkNode* next = head->next;
+            delete head;
+            head = next;
+        }
+        printMemoryUse(rows, "linked list", allocations, (double)bytes, drop, secondsSince(started) * 1000);
+
+        // The description index before it was pooled: one node per expense
+        data = BenchmarkData();
+        unordered_multimap<size_t, uint64_t> descriptions;
+        allocations = allocationCount;
+        bytes = allocatedBytes;
+        for (size_t i = 0; i < rows; i++) {
+            data.next();
+            descriptions.insert(make_pair(hash<string_view>()(data.description), (uint64_t)i + 1));
+        }
+        allocations = allocationCount - allocations;
+        bytes = allocatedBytes - bytes;
+        started = chrono::steady_clock::now();
+        descriptions.clear();
+        printMemoryUse(rows, "multimap index", allocations, (double)bytes, -1, secondsSince(started) * 1000);
+
+        // Columns, description pool and pooled indexes, kept up to date
+        // from the first insert
+        data = BenchmarkData();
+        ExpenseStore store;
+        size_t slot;
+        store.findId(1, slot);
+        allocations = allocationCount;
+        for (size_t i = 0; i < rows; i++) {
+            data.next();
+            store.append(data.amount, data.dateKey, data.category, data.description);
+        }
+        allocations = allocationCount - allocations;
+        double heap = (double)store.memoryUsage().heapBytes;
+        started = chrono::steady_clock::now();
+        store.eraseMonth(month);
+        drop = secondsSince(started) * 1000;
+        started = chrono::steady_clock::now();
+        store.clear();
+        double clear = secondsSince(started) * 1000;
+        printMemoryUse(rows, "column store", allocations, heap, drop, clear);
+        cout << setw(10) << "" << "  heap left after clearing the store: " << store.memoryUsage().heapBytes << " bytes\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    vector<string> args(argv + 1, argv + argc);
+    vector<size_t> sizes;
+    for (size_t i = 1; i < args.size(); i++) {
+        size_t rows = 0;
+        from_chars_result result = from_chars(args[i].data(), args[i].data() + args[i].size(), rows);
+        if (result.ec != errc() || result.ptr != args[i].data() + args[i].size() || rows == 0) {
+            cerr << BENCHMARK_USAGE;
+            return 2;
+        }
+        sizes.push_back(rows);
+    }
+    if (args.empty() || (args[0] != "load" && args[0] != "kernels" && args[0] != "memory")) {
+        cerr << BENCHMARK_USAGE;
+        return 2;
+    }
+    // The files it deletes must not belong to a real account
+    if (LoginSystem().checkUserExists(BENCHMARK_USER)) {
+        cerr << "A user named " << BENCHMARK_USER << " exists here; run the benchmark in another directory.\n";
+        return 2;
+    }
+    ios::sync_with_stdio(false);
+    if (args[0] == "load") {
+        if (sizes.empty()) sizes = {100000, 200000, 400000, 800000};
+        benchmarkLoad(sizes);
+    } else if (args[0] == "kernels") {
+        if (sizes.empty()) sizes = {1000000, 10000000};
+        benchmarkKernels(sizes);
+    } else {
+        if (sizes.empty()) sizes = {100000, 1000000};
+        benchmarkMemory(sizes);
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#!/bin/bash
+# Imports CSV files of 100000 rows with one malformed quote and checks that
+# only the malformed row is lost. The files are large enough to be split
+# into chunks that are parsed in parallel, and the quote sits before the
+# chunk boundaries, where it used to upset where later chunks start.
+#
+# Usage: tests/csv_unbalanced_quote.sh BINARY
+
+BINARY=$(cd "$(dirname "$1")" 2>/dev/null && pwd)/$(basename "$1")
+if [ -z "$1" ] || [ ! -x "$BINARY" ]; then
+    echo "Usage: $0 BINARY" >&2
+    exit 2
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cd "$WORK" || exit 2
+
+# Writes 100000 rows; row BAD is replaced by the text given, and every
+# 1000th row is written by the awk statement in EVERY, if any
+generate() {
+    awk -v bad="$1" -v badText="$2" 'BEGIN {
+        print "Date,Description,Amount,Category"
+        for (i = 1; i <= 100000; i++) {
+            if (i == bad) print badText
+            else if (i % 1000 == 0) '"${3:-printf \"2026-01-05,Row %d,1.00,Food\\n\", i}"'
+            else printf "2026-0%d-%02d,Row %d,1.00,Food\n", 1 + i % 9, 1 + i % 28, i
+        }
+    }'
+}
+
+# Imports file as a new user and compares the rejected lines and counts,
+# leaving out the time
+check() {
+    local name=$1 expected=$2
+    rm -rf tester_expenses tester_expenses.journal
+    printf 'tester\npassword\n' > users.txt
+    local got
+    got=$(printf 'import %s\n' "$name.csv" | "$BINARY" --batch tester 2>&1 |
+          awk '/^rejected / { printf "%s ", $0 } /^ok / { printf "ok %s %s", $2, $3 }')
+    if [ "$got" = "$expected" ]; then
+        echo "$name: ok"
+    else
+        echo "$name: got \"$got\", expected \"$expected\"" >&2
+        failures=$((failures + 1))
+    fi
+}
+
+failures=0
+
+# A quote opens a field and is never closed
+generate 500 '2026-01-05,"Joe s Diner,12.00,Food' > unclosed.csv
+check unclosed "rejected 501: unbalanced quote ok 99999 1"
+
+# The same, with properly quoted fields further on that it must not pair with
+generate 500 '2026-01-05,"Joe s Diner,12.00,Food' 'printf "2026-01-05,\"Row %d, quoted\",1.00,Food\n", i' > paired.csv
+check paired "rejected 501: unbalanced quote ok 99999 1"
+
+# A quote inside an unquoted field is kept as text, and fields quoted over
+# two lines further on still import whole
+generate 10 '2026-01-05,Joe"s,2.00,Food' 'printf "2026-01-05,\"Row %d\nsecond line\",1.00,Food\n", i' > literal.csv
+check literal "ok 100000 0"
+
+[ "$failures" -eq 0 ]
@@ -0,0 +1,149 @@
+#!/bin/bash
+# Kills the tracker with SIGKILL at random points while it saves, then checks
+# that the next run reads back either everything before the command or
+# everything after it, never a mix.
+#
+# Usage: tests/kill_during_save.sh BINARY [RUNS] [BASE_ROWS] [EXTRA_ROWS]
+#
+# Two commands are interrupted, each RUNS times (default 20):
+#   import extra.csv   merges a CSV and checkpoints every month it touched
+#   clear YYYY-MM      drops the current month, journals it and checkpoints
+#                      on exit
+# Then a journal of 100 adds, left behind by a kill, is cut at RUNS random
+# lengths, as a power loss in the middle of a write would leave it. The next
+# run has to keep exactly the adds whose lines are complete, and still
+# append after the cut.
+# The data lives in a scratch directory, so existing accounts are untouched.
+
+BINARY=$(cd "$(dirname "$1")" 2>/dev/null && pwd)/$(basename "$1")
+RUNS=${2:-20}
+BASE_ROWS=${3:-200000}
+EXTRA_ROWS=${4:-20000}
+if [ -z "$1" ] || [ ! -x "$BINARY" ]; then
+    echo "Usage: $0 BINARY [RUNS] [BASE_ROWS] [EXTRA_ROWS]" >&2
+    exit 2
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cd "$WORK" || exit 2
+
+# Writes ROWS expenses spread over the 24 months up to the current one
+generate() {
+    awk -v rows="$1" -v seed="$2" -v year="$(date +%Y)" -v month="$(date +%m)" 'BEGIN {
+        srand(seed)
+        split("Food,Transport,Shopping,Bills,Health,Other", categories, ",")
+        print "Id,Date,Description,Amount,Category"
+        for (i = 1; i <= rows; i++) {
+            back = int(rand() * 24)
+            m = month - 1 - back
+            y = year
+            while (m < 0) { m += 12; y-- }
+            m++
+            printf "%d,%04d-%02d-%02d,Shop %d,%.2f,%s\n", i, y, m, 1 + int(rand() * 28),
+                   int(rand() * 5000), 1 + rand() * 2000, categories[1 + int(rand() * 6)]
+        }
+    }'
+}
+
+run() {
+    printf '%s\n' "$1" | "$BINARY" --batch tester > /dev/null 2>&1
+}
+
+# Lists every expense, which reads every partition back, and sums up the
+# rows; "total" alone would answer from the manifest. Notices such as a
+# journal recovery are left out.
+contents() {
+    printf 'list\ntotal\n' | timeout 120 "$BINARY" --batch tester 2>&1 | awk '/^ok |^[0-9]+\t/' | cksum
+}
+
+mkdir base
+printf 'tester\npassword\n' > base/users.txt
+generate "$BASE_ROWS" 1 > base.csv
+generate "$EXTRA_ROWS" 2 > extra.csv
+(cd base && run "import ../base.csv") || { echo "could not build the base data" >&2; exit 2; }
+
+failures=0
+for command in "import ../extra.csv" "clear $(date +%Y-%m)"; do
+    rm -rf run && cp -r base run && cd run || exit 2
+    before=$(contents)
+    start=$(date +%s%N)
+    run "$command"
+    duration=$(( $(date +%s%N) - start ))
+    after=$(contents)
+    cd ..
+    if [ "$before" = "$after" ]; then
+        echo "$command: changes nothing ($before)" >&2
+        exit 2
+    fi
+
+    old=0; new=0; bad=0
+    for i in $(seq "$RUNS"); do
+        rm -rf run && cp -r base run && cd run || exit 2
+        # Anywhere from the start of the run to a little past its end
+        delay=$(awk -v seed="$RANDOM" -v ns="$duration" 'BEGIN { srand(seed); printf "%.3f", rand() * ns * 1.2 / 1e9 }')
+        printf '%s\n' "$command" > ../command.txt
+        "$BINARY" --batch tester ../command.txt > /dev/null 2>&1 &
+        pid=$!
+        sleep "$delay"
+        kill -9 "$pid" 2>/dev/null
+        wait "$pid" 2>/dev/null
+        got=$(contents)
+        if [ "$got" = "$before" ]; then
+            old=$((old + 1))
+        elif [ "$got" = "$after" ]; then
+            new=$((new + 1))
+        else
+            bad=$((bad + 1))
+            echo "$command: killed after ${delay}s, read back neither the old nor the new data" >&2
+        fi
+        cd ..
+    done
+    echo "$command: $RUNS kills, $old before, $new after, $bad broken"
+    failures=$((failures + bad))
+done
+
+# Prints the row count and the total
+counts() {
+    printf 'list\ntotal\n' | timeout 120 "$BINARY" --batch tester 2>&1 | awk '/^ok / { printf "%s ", $2 } END { print "" }'
+}
+
+ADDS=100
+DAY=$(date +%Y-%m)-01
+rm -rf journaled && cp -r base journaled && cd journaled || exit 2
+read -r rows total <<< "$(counts)"
+mkfifo ../commands
+"$BINARY" --batch tester < ../commands > ../added.txt 2>&1 &
+pid=$!
+exec 3> ../commands
+for i in $(seq "$ADDS"); do printf 'add 1 %s Food Added\n' "$DAY" >&3; done
+printf 'sync\n' >&3
+# The adds are on the disk once sync answers; the kill keeps them in the
+# journal instead of a checkpoint
+until [ "$(grep -c '^ok' ../added.txt)" -gt "$ADDS" ]; do sleep 0.1; done
+{ kill -9 "$pid"; wait "$pid"; } 2>/dev/null
+exec 3>&-
+cd ..
+journal=journaled/tester_expenses.journal
+size=$(wc -c < "$journal")
+headerSize=$(head -1 "$journal" | wc -c)
+
+bad=0
+for i in $(seq "$RUNS"); do
+    rm -rf run && cp -r journaled run && cd run || exit 2
+    cut=$(awk -v seed="$RANDOM" -v low="$headerSize" -v high="$size" 'BEGIN { srand(seed); print low + int(rand() * (high - low + 1)) }')
+    head -c "$cut" ../$journal > tester_expenses.journal
+    complete=$(( $(tr -cd '\n' < tester_expenses.journal | wc -c) - 1 ))
+    printf 'add 1 %s Food After\n' "$DAY" | "$BINARY" --batch tester > /dev/null 2>&1
+    expected=$(awk -v rows="$rows" -v total="$total" -v adds="$((complete + 1))" 'BEGIN { printf "%d %.2f ", rows + adds, total + adds }')
+    got=$(counts)
+    if [ "$got" != "$expected" ]; then
+        bad=$((bad + 1))
+        echo "journal cut at $cut of $size bytes: read back \"$got\", expected \"$expected\"" >&2
+    fi
+    cd ..
+done
+echo "journal tail: $RUNS cuts, $bad broken"
+failures=$((failures + bad))
+
+[ "$failures" -eq 0 ]